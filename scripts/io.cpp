@@ -29,15 +29,15 @@ void quotationRemover(string& fileName) {
         fileName = fileName.substr(1, fileName.size() - 2);
 }
 
-// Функция для чтения байтов из файла
-FileData readBytesFromFile(const string& defaultFileName) {
+// Функция для открытия входного файла. Возвращает имя выбранного файла
+string openInputFile(const string& defaultFileName, ifstream& file) {
     cout << "Введите имя/путь до файла (или Enter для использования '" << defaultFileName << "'): ";
     string fileName;
     getline(cin, fileName);
     if (fileName.empty()) fileName = defaultFileName;
     quotationRemover(fileName);
 
-    ifstream file(fileName, ios::binary);
+    file.open(fileName, ios::binary);
     if (!file.is_open()) {
         cout << "Файл \"" << fileName << "\" не найден. Создать новый? (y/n): ";
         string answer;
@@ -50,19 +50,30 @@ FileData readBytesFromFile(const string& defaultFileName) {
             getline(cin, textInput);
             fout.write(reinterpret_cast<const char*>(textInput.data()), textInput.size());
             fout.close();
-            return {fileName, vector<unsigned char>(textInput.begin(), textInput.end())};
+
+            file.clear();
+            file.open(fileName, ios::binary);
+            if (!file.is_open()) throw runtime_error("Не удалось открыть файл: " + fileName);
         } 
         else throw runtime_error("Создание отменено: " + fileName);
     }
-    
+
+    if (file.peek() == ifstream::traits_type::eof())
+        throw runtime_error("Файл \"" + fileName + "\" пустой или не содержит байтов.");
+    return fileName;
+}
+
+// Функция для чтения байтов из файла
+FileData readBytesFromFile(const string& defaultFileName) {
+    ifstream file;
+    string fileName = openInputFile(defaultFileName, file);
     vector<unsigned char> content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
     file.close();
-    if (content.empty()) throw runtime_error("Файл \"" + fileName + "\" пустой или не содержит байтов.");
     return {fileName, content};
 }
 
-// Функция для записи байтов в файл
-void writeBytesToFile(const string& defaultFileName, const vector<unsigned char>& content) {
+// Функция для открытия файла на запись. Возвращает имя выбранного файла
+string openOutputFile(const string& defaultFileName, ofstream& file) {
     cout << "Введите имя/путь до файла для сохранения (или Enter для использования '" << defaultFileName << "'): ";
     string fileName;
     getline(cin, fileName);
@@ -70,9 +81,15 @@ void writeBytesToFile(const string& defaultFileName, const vector<unsigned char>
 
     quotationRemover(fileName);
 
-    ofstream file(fileName, ios::binary);
+    file.open(fileName, ios::binary);
     if (!file.is_open()) throw runtime_error("Не удалось открыть/создать файл: " + fileName);
-    
+    return fileName;
+}
+
+// Функция для записи байтов в файл
+void writeBytesToFile(const string& defaultFileName, const vector<unsigned char>& content) {
+    ofstream file;
+    string fileName = openOutputFile(defaultFileName, file);
     file.write(reinterpret_cast<const char*>(content.data()), content.size());
     cout << "Содержимое записано в файл: " << fileName << endl;
     file.close();
@@ -14,7 +14,9 @@ struct FileData {
 
 void trimWhitespace(std::string& str);
 void quotationRemover(std::string& fileName);
+std::string openInputFile(const std::string& defaultFileName, std::ifstream& file);
 FileData readBytesFromFile(const std::string& defaultFileName);
+std::string openOutputFile(const std::string& defaultFileName, std::ofstream& file);
 void writeBytesToFile(const std::string& defaultFileName, const std::vector<unsigned char>& content);
 std::vector<unsigned char> readBytesFromInput(const std::string& arg);
 std::vector<unsigned char> genRandomKey(size_t length);
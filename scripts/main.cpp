@@ -1,12 +1,16 @@
 #include "cipher/ciphers.h"
 #include "cipher/interface.h"
+#include "stage/interface.h"
+#include "pipeline.h"
 
 #include <iostream>
 #include <limits>
 #include <map>
+#include <sstream>
 #include <dlfcn.h>
 #include <vector>
 #include <string>
+#include <utility>
 
 using namespace std;
 
@@ -14,6 +18,10 @@ using namespace std;
 map<string, CipherModule*> loadedCiphers;
 map<string, void*> dlHandles;
 
+// Мап для загруженных стадий конвейера и их хэндлов
+map<string, StageModule*> loadedStages;
+map<string, void*> stageHandles;
+
 // Статус для каждого шифра
 bool isVernamWorking = false;
 bool isAutokeyWorking = false;
@@ -51,23 +59,66 @@ void loadCipherModule(const string& cipherName) {
     else if (cipherName == "SALSA20") isSalsa20Working = true;
 }
 
+// Загрузка стадии конвейера. Новые стадии подключаются без пересборки приложения
+StageModule* loadStageModule(const string& stageName) {
+    if (loadedStages.count(stageName)) return loadedStages[stageName];
+    // Имя подставляется в путь к библиотеке, поэтому пути в нем запрещены
+    if (stageName.find('/') != string::npos)
+        throw invalid_argument("Имя стадии не должно содержать '/': " + stageName);
+
+    string libPath = "./lib" + stageName + ".so";
+    void* handle = dlopen(libPath.c_str(), RTLD_LAZY);
+    if (!handle) {
+        libPath = "lib" + stageName + ".so";
+        handle = dlopen(libPath.c_str(), RTLD_LAZY);
+        if (!handle) throw runtime_error("Ошибка при загрузке стадии " + libPath + ": " + dlerror());
+    }
+
+    StageModule* (*createFunction)() = reinterpret_cast<StageModule* (*)()>(dlsym(handle, "createStageModule"));
+    if (!createFunction) {
+        dlclose(handle);
+        throw runtime_error("Не удалось найти функцию createStageModule в библиотеке " + libPath + ": " + dlerror());
+    }
+
+    StageModule* stage = createFunction();
+    if (loadedStages.count(stage->name)) { // Та же стадия уже загружена под другим именем файла
+        dlclose(handle);
+        return loadedStages[stage->name];
+    }
+    loadedStages[stage->name] = stage;
+    stageHandles[stage->name] = handle;
+    return stage;
+}
+
+// Чтение списка стадий, выполняемых перед шифрованием
+vector<string> readStageNames() {
+    cout << "Введите стадии перед шифрованием через пробел, например LZFAST (или Enter без стадий): ";
+    string line;
+    getline(cin, line);
+
+    vector<string> stageNames;
+    istringstream stream(line);
+    string stageName;
+    while (stream >> stageName) stageNames.push_back(stageName);
+    return stageNames;
+}
+
 // Манипуляции с введенными значениями
 void executeInput(int cipherChoice, int inputChoice, int keyChoice) {
     vector<unsigned char> keyBytes;
     vector<unsigned char> nonceBytes;
-    vector<unsigned char>* pInputTextBytes = nullptr;
     vector<unsigned char> inputTextFromManualInput;
 
-    FileData inputFileData;
+    // Файл не читается целиком заранее: стадии обрабатывают его при чтении
+    ifstream inputFile;
+    string inputFileName;
 
     switch (inputChoice) {
         case 1:
             inputTextFromManualInput = readBytesFromInput("текст");
-            pInputTextBytes = &inputTextFromManualInput;
             break;
         case 2:
-            inputFileData = readBytesFromFile("source/input/input.txt");
-            pInputTextBytes = &inputFileData.content;
+            inputFileName = openInputFile("source/input/input.txt", inputFile);
             break;
         default: throw invalid_argument("Неверный выбор способа ввода текста. Нужно выбрать 1 или 2");
     }
@@ -84,6 +135,16 @@ void executeInput(int cipherChoice, int inputChoice, int keyChoice) {
         throw runtime_error("Ошибка. Шифр " + cipherName + " не загружен. Проверьте файлы .so");
     CipherModule* currentCipher = loadedCiphers[cipherName];
 
+    Pipeline pipeline;
+    for (const string& stageName : readStageNames()) addStage(pipeline, loadStageModule(stageName));
+
+    // Стадии выполняются один раз до выбора ключа: ключ Вернама должен покрывать уже преобразованные данные
+    size_t cipherStep = pipeline.steps.size();
+    vector<unsigned char> stagedText = (inputChoice == 2)
+        ? runPipelineForward(pipeline, inputFile)
+        : runPipelineForward(pipeline, move(inputTextFromManualInput));
+    inputFile.close();
+
     if (cipherChoice == 3) {
         size_t requiredKeyLen = 32;
 
@@ -125,8 +186,8 @@ void executeInput(int cipherChoice, int inputChoice, int keyChoice) {
                 break;
             case 3:
                 if (cipherChoice == 1) {
-                    keyBytes = genRandomKey(pInputTextBytes->size());
-                    cout << "Сгенерирован случайный ключ для Вернама (" << pInputTextBytes->size() << " байт)." << endl;
+                    keyBytes = genRandomKey(stagedText.size());
+                    cout << "Сгенерирован случайный ключ для Вернама (" << stagedText.size() << " байт)." << endl;
                 } else {
                     keyBytes = genRandomKey(16);
                     cout << "Сгенерирован случайный ключ для автоключа (16 байт)." << endl;
@@ -138,15 +199,21 @@ void executeInput(int cipherChoice, int inputChoice, int keyChoice) {
 
     const vector<unsigned char>* pNonce = (cipherChoice == 3) ? &nonceBytes : nullptr;
     
-    string extension = (inputChoice == 2) ? getFileExtension(inputFileData.fileName) : ".txt";
+    string extension = (inputChoice == 2) ? getFileExtension(inputFileName) : ".txt";
     
-    vector<unsigned char> encryptedText = currentCipher->encryptFunction(*pInputTextBytes, keyBytes, pNonce);
+    addCipher(pipeline, currentCipher, keyBytes, pNonce);
+    cout << "Конвейер: " << describePipeline(pipeline) << endl;
+
+    vector<unsigned char> encryptedText = runPipelineForward(pipeline, move(stagedText), cipherStep);
     string encryptedFileName = "source/output/" + cipherName + "_encrypted" + extension;
     writeBytesToFile(encryptedFileName, encryptedText);
 
-    vector<unsigned char> decryptedText = currentCipher->decryptFunction(encryptedText, keyBytes, pNonce);
+    // Расшифрованные данные пишутся в файл по мере распаковки
     string decryptedFileName = "source/output/" + cipherName + "_decrypted" + extension;
-    writeBytesToFile(decryptedFileName, decryptedText); 
+    ofstream decryptedFile;
+    decryptedFileName = openOutputFile(decryptedFileName, decryptedFile);
+    runPipelineInverse(pipeline, move(encryptedText), decryptedFile);
+    cout << "Содержимое записано в файл: " << decryptedFileName << endl;
 }
 
 // Точка входа
@@ -259,5 +326,8 @@ int main() {
     for (auto const& [name, handle] : dlHandles) {
         if(handle) dlclose(handle);
     }
+    for (auto const& [name, handle] : stageHandles) {
+        if(handle) dlclose(handle);
+    }
     return 0;
 }
\ No newline at end of file
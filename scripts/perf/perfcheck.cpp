@@ -0,0 +1,421 @@
+#include "cipher/interface.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <functional>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+using namespace std;
+
+// Шифры, которые прогоняет профилировщик
+const vector<string> CIPHER_NAMES = {"VERNAM", "AUTOKEY", "SALSA20"};
+const int REPEATS = 5; // Из повторов берется самый быстрый
+
+// Счетчики perf_event_open. Аппаратные счетчики открываются одной группой
+// с лидером cycles, поэтому все они считаются на одном и том же интервале
+enum CounterId { TASK_CLOCK, CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, COUNTER_COUNT };
+
+struct Counter {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+    int fd;
+    int groupIndex; // Позиция в групповом чтении, -1 - не в группе
+};
+
+Counter counters[COUNTER_COUNT] = {
+    {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, -1, -1},
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1, -1},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1, -1},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1, -1},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, -1, -1},
+};
+
+int groupSize = 0;
+
+// Результат одного замера. Отрицательное значение - счетчик недоступен
+struct Sample {
+    double values[COUNTER_COUNT];
+    double wallNs;
+};
+
+// Открытие счетчика для текущего процесса, только пользовательский режим.
+// Члены группы включаются и выключаются вместе с лидером
+int openCounter(uint32_t type, uint64_t config, int groupFd, uint64_t readFormat) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = groupFd < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = readFormat;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+bool hardwareCountersAvailable() {
+    return counters[CYCLES].fd >= 0;
+}
+
+// Открываем все счетчики. Недоступные просто пропускаются
+void openCounters() {
+    const uint64_t timeFormat = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    const uint64_t groupFormat = timeFormat | PERF_FORMAT_GROUP;
+
+    Counter& clock = counters[TASK_CLOCK];
+    clock.fd = openCounter(clock.type, clock.config, -1, timeFormat);
+    if (clock.fd < 0) cerr << "Счетчик " << clock.name << " недоступен: " << strerror(errno) << endl;
+
+    Counter& leader = counters[CYCLES];
+    leader.fd = openCounter(leader.type, leader.config, -1, groupFormat);
+    if (leader.fd < 0) {
+        cerr << "Аппаратные счетчики недоступны: " << strerror(errno) << endl;
+        return;
+    }
+    leader.groupIndex = groupSize++;
+
+    for (int id = INSTRUCTIONS; id < COUNTER_COUNT; ++id) {
+        Counter& counter = counters[id];
+        counter.fd = openCounter(counter.type, counter.config, leader.fd, groupFormat);
+        if (counter.fd < 0) {
+            cerr << "Счетчик " << counter.name << " недоступен: " << strerror(errno) << endl;
+            continue;
+        }
+        counter.groupIndex = groupSize++;
+    }
+}
+
+void closeCounters() {
+    for (Counter& counter : counters) {
+        if (counter.fd >= 0) close(counter.fd);
+        counter.fd = -1;
+        counter.groupIndex = -1;
+    }
+    groupSize = 0;
+}
+
+// Чтение task-clock с поправкой на мультиплексирование
+double readClock() {
+    const Counter& clock = counters[TASK_CLOCK];
+    if (clock.fd < 0) return -1;
+    uint64_t data[3]; // значение, время включения, время работы
+    if (read(clock.fd, data, sizeof(data)) != sizeof(data) || data[2] == 0) return -1;
+    return static_cast<double>(data[0]) * data[1] / data[2];
+}
+
+// Чтение всей группы одним вызовом. Поправка на мультиплексирование общая для группы
+void readGroup(double* values) {
+    if (!hardwareCountersAvailable()) return;
+    vector<uint64_t> data(3 + groupSize); // число счетчиков, время включения, время работы, значения
+    ssize_t expected = static_cast<ssize_t>(data.size() * sizeof(uint64_t));
+    if (read(counters[CYCLES].fd, data.data(), expected) != expected || data[2] == 0) return;
+
+    double scale = static_cast<double>(data[1]) / data[2];
+    for (int id = CYCLES; id < COUNTER_COUNT; ++id) {
+        if (counters[id].groupIndex >= 0) values[id] = data[3 + counters[id].groupIndex] * scale;
+    }
+}
+
+// Замер одного прогона ядра
+Sample measure(const function<void()>& kernel) {
+    int clockFd = counters[TASK_CLOCK].fd;
+    int leaderFd = counters[CYCLES].fd;
+    if (clockFd >= 0) {
+        ioctl(clockFd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(clockFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    if (leaderFd >= 0) {
+        ioctl(leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    auto start = chrono::steady_clock::now();
+    kernel();
+    auto end = chrono::steady_clock::now();
+    if (leaderFd >= 0) ioctl(leaderFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (clockFd >= 0) ioctl(clockFd, PERF_EVENT_IOC_DISABLE, 0);
+
+    Sample sample;
+    for (double& value : sample.values) value = -1;
+    sample.values[TASK_CLOCK] = readClock();
+    readGroup(sample.values);
+    sample.wallNs = chrono::duration<double, nano>(end - start).count();
+    return sample;
+}
+
+// Итоговые метрики ядра. Отрицательное значение - метрика недоступна
+struct KernelReport {
+    string name;
+    double cyclesPerByte;
+    double instructionsPerByte;
+    double ipc;
+    double cacheMissesPerKb;
+    double branchMissesPerKb;
+    double nsPerByte;
+};
+
+KernelReport makeReport(const string& name, const Sample& sample, size_t bytes) {
+    const double* v = sample.values;
+    KernelReport report;
+    report.name = name;
+    report.cyclesPerByte = v[CYCLES] > 0 ? v[CYCLES] / bytes : -1;
+    report.instructionsPerByte = v[INSTRUCTIONS] >= 0 ? v[INSTRUCTIONS] / bytes : -1;
+    report.ipc = (v[CYCLES] > 0 && v[INSTRUCTIONS] >= 0) ? v[INSTRUCTIONS] / v[CYCLES] : -1;
+    report.cacheMissesPerKb = v[CACHE_MISSES] >= 0 ? v[CACHE_MISSES] * 1024 / bytes : -1;
+    report.branchMissesPerKb = v[BRANCH_MISSES] >= 0 ? v[BRANCH_MISSES] * 1024 / bytes : -1;
+    // Без task-clock время берется по стенным часам
+    report.nsPerByte = (v[TASK_CLOCK] > 0 ? v[TASK_CLOCK] : sample.wallNs) / bytes;
+    return report;
+}
+
+// Прогон ядра несколько раз, выбирается самый быстрый замер
+KernelReport profileKernel(const string& name, size_t bytes, const function<void()>& kernel) {
+    kernel(); // Прогрев
+    Sample best = measure(kernel);
+    for (int i = 1; i < REPEATS; ++i) {
+        Sample sample = measure(kernel);
+        bool faster = best.values[CYCLES] > 0
+            ? sample.values[CYCLES] < best.values[CYCLES]
+            : sample.wallNs < best.wallNs;
+        if (faster) best = sample;
+    }
+    return makeReport(name, best, bytes);
+}
+
+// Загрузка шифра через createCipherModule, как в основном приложении
+CipherModule* loadCipherModule(const string& cipherName, vector<void*>& handles) {
+    string libPath = "lib" + cipherName + ".so";
+    void* handle = dlopen(libPath.c_str(), RTLD_LAZY);
+    if (!handle) throw runtime_error("Ошибка при загрузке библиотеки " + libPath + ": " + dlerror());
+    handles.push_back(handle);
+
+    CipherModule* (*createFunction)() = reinterpret_cast<CipherModule* (*)()>(dlsym(handle, "createCipherModule"));
+    if (!createFunction)
+        throw runtime_error("Не удалось найти функцию createCipherModule в библиотеке " + libPath + ": " + dlerror());
+    return createFunction();
+}
+
+// Прогон шифрования и дешифрования одного модуля
+void profileCipher(const CipherModule* module, size_t size, vector<KernelReport>& reports) {
+    mt19937 rng(42);
+    auto randomBytes = [&rng](size_t length) {
+        vector<unsigned char> bytes(length);
+        for (unsigned char& byte : bytes) byte = static_cast<unsigned char>(rng());
+        return bytes;
+    };
+
+    vector<unsigned char> inputText = randomBytes(size);
+    vector<unsigned char> key = randomBytes(module->name == "VERNAM" ? size : (module->name == "SALSA20" ? 32 : 16));
+    vector<unsigned char> nonce = randomBytes(8);
+    const vector<unsigned char>* pNonce = module->name == "SALSA20" ? &nonce : nullptr;
+
+    vector<unsigned char> cipherText = module->encryptFunction(inputText, key, pNonce);
+    if (module->decryptFunction(cipherText, key, pNonce) != inputText)
+        throw runtime_error("Шифр " + module->name + " не восстановил исходные данные");
+
+    vector<unsigned char> result;
+    reports.push_back(profileKernel(module->name + ".encrypt", size, [&]() {
+        result = module->encryptFunction(inputText, key, pNonce);
+    }));
+    reports.push_back(profileKernel(module->name + ".decrypt", size, [&]() {
+        result = module->decryptFunction(cipherText, key, pNonce);
+    }));
+}
+
+// Вывод значения метрики или прочерка
+string formatMetric(double value) {
+    if (value < 0) return "-";
+    ostringstream stream;
+    stream << fixed << setprecision(3) << value;
+    return stream.str();
+}
+
+void printReports(const vector<KernelReport>& reports, size_t size) {
+    cout << "Размер буфера: " << size << " байт, повторов: " << REPEATS << endl;
+    cout << left << setw(18) << "kernel" << right
+        << setw(14) << "cycles/byte" << setw(14) << "instr/byte" << setw(10) << "IPC"
+        << setw(16) << "cache-miss/KB" << setw(16) << "branch-miss/KB" << setw(12) << "ns/byte" << endl;
+    for (const KernelReport& report : reports) {
+        cout << left << setw(18) << report.name << right
+            << setw(14) << formatMetric(report.cyclesPerByte) << setw(14) << formatMetric(report.instructionsPerByte)
+            << setw(10) << formatMetric(report.ipc)
+            << setw(16) << formatMetric(report.cacheMissesPerKb) << setw(16) << formatMetric(report.branchMissesPerKb)
+            << setw(12) << formatMetric(report.nsPerByte) << endl;
+    }
+}
+
+// Эталон: строки "ядро метрика значение", # - комментарий
+typedef map<string, map<string, double>> Baseline;
+
+Baseline readBaseline(const string& fileName) {
+    ifstream file(fileName);
+    if (!file.is_open()) throw runtime_error("Не удалось открыть эталон: " + fileName);
+
+    Baseline baseline;
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream stream(line);
+        string kernel, metric;
+        double value;
+        if (!(stream >> kernel >> metric >> value))
+            throw runtime_error("Некорректная строка эталона: " + line);
+        baseline[kernel][metric] = value;
+    }
+    return baseline;
+}
+
+// Эталон пишется только по аппаратным счетчикам, иначе по нему нечего проверять
+void writeBaseline(const string& fileName, const vector<KernelReport>& reports, size_t size) {
+    for (const KernelReport& report : reports) {
+        if (report.cyclesPerByte < 0 || report.instructionsPerByte < 0)
+            throw runtime_error("Аппаратные счетчики cycles/instructions недоступны, эталон не записан");
+    }
+
+    ofstream file(fileName);
+    if (!file.is_open()) throw runtime_error("Не удалось открыть/создать файл: " + fileName);
+
+    file << "# Эталон для make perfcheck (размер буфера " << size << " байт)" << endl;
+    file << "# ядро метрика значение" << endl;
+    for (const KernelReport& report : reports) {
+        file << report.name << " instructions/byte " << formatMetric(report.instructionsPerByte) << endl;
+        file << report.name << " cycles/byte " << formatMetric(report.cyclesPerByte) << endl;
+        file << report.name << " ns/byte " << formatMetric(report.nsPerByte) << endl;
+    }
+    cout << "Эталон записан в файл: " << fileName << endl;
+}
+
+// Вывод строки сравнения. Возвращает true, если порог превышен
+bool compareMetric(const string& kernel, const string& metric, double value, double expected, double threshold, bool gated) {
+    double change = (value / expected - 1) * 100;
+    bool slower = change > threshold;
+    cout << kernel << " " << metric << ": " << formatMetric(value)
+        << " (эталон " << formatMetric(expected) << ", "
+        << showpos << fixed << setprecision(1) << change << noshowpos << "%)"
+        << (slower ? (gated ? " РЕГРЕССИЯ" : " медленнее (только для справки)") : "") << endl;
+    return slower;
+}
+
+// Сравнение с эталоном. Возвращает число провалов проверки.
+// С аппаратными счетчиками проверяются инструкции на байт (детерминированы)
+// и такты на байт. Если нужной метрики нет в эталоне или ее не удалось
+// измерить, проверка не может поймать регрессию и это тоже считается провалом.
+// Без счетчиков время на байт выводится только для справки - оно слишком шумное
+int compareWithBaseline(const vector<KernelReport>& reports, const Baseline& baseline, double threshold, bool hardware) {
+    int failures = 0;
+
+    for (const KernelReport& report : reports) {
+        auto kernel = baseline.find(report.name);
+        if (kernel == baseline.end()) {
+            cout << report.name << ": нет в эталоне" << (hardware ? ", ПРОВЕРКА ОТКЛЮЧЕНА" : ", пропущено") << endl;
+            if (hardware) ++failures;
+            continue;
+        }
+
+        if (!hardware) {
+            auto expected = kernel->second.find("ns/byte");
+            if (expected != kernel->second.end() && expected->second > 0)
+                compareMetric(report.name, "ns/byte", report.nsPerByte, expected->second, threshold, false);
+            continue;
+        }
+
+        const pair<string, double> metrics[] = {
+            {"instructions/byte", report.instructionsPerByte},
+            {"cycles/byte", report.cyclesPerByte},
+        };
+        for (const auto& [metric, value] : metrics) {
+            // Лидер группы открылся, но метрика не прочиталась: группа не была
+            // запланирована, чтение оборвалось или счетчик не открылся
+            if (value < 0) {
+                cout << report.name << " " << metric << ": счетчик не прочитан, ПРОВЕРКА ОТКЛЮЧЕНА" << endl;
+                ++failures;
+                continue;
+            }
+            auto expected = kernel->second.find(metric);
+            if (expected == kernel->second.end() || expected->second <= 0) {
+                cout << report.name << " " << metric << ": нет в эталоне, ПРОВЕРКА ОТКЛЮЧЕНА" << endl;
+                ++failures;
+                continue;
+            }
+            if (compareMetric(report.name, metric, value, expected->second, threshold, true)) ++failures;
+        }
+    }
+
+    if (!hardware)
+        cout << "Аппаратные счетчики недоступны, проверка регрессий не выполнялась" << endl;
+    else if (failures)
+        cout << "Если эталон устарел или записан без счетчиков, обновите его через make perfbaseline" << endl;
+    return failures;
+}
+
+// Точка входа
+int main(int argc, char* argv[]) {
+    string baselineFile;
+    string writeBaselineFile;
+    double threshold = 10;
+    size_t size = 1 << 20;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (i + 1 >= argc) throw invalid_argument("Нет значения для аргумента " + arg);
+            if (arg == "--baseline") baselineFile = argv[++i];
+            else if (arg == "--write-baseline") writeBaselineFile = argv[++i];
+            else if (arg == "--threshold") threshold = stod(argv[++i]);
+            else if (arg == "--size") size = stoul(argv[++i]);
+            else throw invalid_argument("Неизвестный аргумент " + arg);
+        }
+        if (size == 0) throw invalid_argument("Размер буфера должен быть больше нуля");
+
+        vector<void*> handles;
+        vector<KernelReport> reports;
+        openCounters();
+        bool hardware = hardwareCountersAvailable();
+        for (const string& cipherName : CIPHER_NAMES)
+            profileCipher(loadCipherModule(cipherName, handles), size, reports);
+        closeCounters();
+        for (void* handle : handles) dlclose(handle);
+
+        printReports(reports, size);
+
+        if (!writeBaselineFile.empty()) writeBaseline(writeBaselineFile, reports, size);
+        if (baselineFile.empty()) return 0;
+
+        cout << "\nСравнение с эталоном " << baselineFile << " (порог " << threshold << "%)" << endl;
+        if (!ifstream(baselineFile).is_open()) {
+            if (!hardware) {
+                cout << "Эталон не найден, аппаратные счетчики недоступны, проверка регрессий не выполнялась" << endl;
+                return 0;
+            }
+            cout << "Эталон не найден, ПРОВЕРКА ОТКЛЮЧЕНА. Запишите его через make perfbaseline" << endl;
+            return 1;
+        }
+
+        int failures = compareWithBaseline(reports, readBaseline(baselineFile), threshold, hardware);
+        if (failures) {
+            cout << "Проверка не пройдена: " << failures << endl;
+            return 1;
+        }
+        if (hardware) cout << "Регрессий нет" << endl;
+    }
+    catch (const exception& e) {
+        cerr << "Ошибка. " << e.what() << endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "pipeline.h"
+
+#include <utility>
+#include <stdexcept>
+#include <iterator>
+
+using namespace std;
+
+// Добавление стадии из динамической библиотеки
+void addStage(Pipeline& pipeline, const StageModule* stage) {
+    pipeline.steps.push_back({stage->name, stage->forwardFunction, stage->inverseFunction, stage});
+}
+
+// Добавление шифра как шага конвейера. Ключ и Nonce копируются в шаг
+void addCipher(
+    Pipeline& pipeline,
+    const CipherModule* cipher,
+    const vector<unsigned char>& key,
+    const vector<unsigned char>* pNonce)
+{
+    bool hasNonce = pNonce != nullptr;
+    vector<unsigned char> nonce = hasNonce ? *pNonce : vector<unsigned char>();
+    CipherFunc encrypt = cipher->encryptFunction;
+    CipherFunc decrypt = cipher->decryptFunction;
+
+    // Шифры возвращают новый буфер, он перемещается в выходной без копирования
+    pipeline.steps.push_back({
+        cipher->name,
+        [=](const vector<unsigned char>& input, vector<unsigned char>& output) {
+            output = encrypt(input, key, hasNonce ? &nonce : nullptr);
+        },
+        [=](const vector<unsigned char>& input, vector<unsigned char>& output) {
+            output = decrypt(input, key, hasNonce ? &nonce : nullptr);
+        }
+    });
+}
+
+// Строка вида "LZFAST -> SALSA20"
+string describePipeline(const Pipeline& pipeline) {
+    string description;
+    for (const PipelineStep& step : pipeline.steps) {
+        if (!description.empty()) description += " -> ";
+        description += step.name;
+    }
+    return description;
+}
+
+// Прямой проход начиная с шага firstStep. Входной буфер передается по значению,
+// чтобы вызывающий мог отдать его через move. Стадии пишут в буфер next,
+// который после swap переиспользуется следующей стадией вместе с выделенной памятью
+vector<unsigned char> runPipelineForward(const Pipeline& pipeline, vector<unsigned char> input, size_t firstStep) {
+    vector<unsigned char> next;
+    for (size_t i = firstStep; i < pipeline.steps.size(); ++i) {
+        next.clear();
+        pipeline.steps[i].forward(input, next);
+        swap(input, next);
+    }
+    return input;
+}
+
+// Обратный проход, шаги идут с конца
+vector<unsigned char> runPipelineInverse(const Pipeline& pipeline, vector<unsigned char> input) {
+    vector<unsigned char> next;
+    for (auto it = pipeline.steps.rbegin(); it != pipeline.steps.rend(); ++it) {
+        next.clear();
+        it->inverse(input, next);
+        swap(input, next);
+    }
+    return input;
+}
+
+// Прямой проход для данных из файла. Если первая стадия поддерживает потоковую обработку,
+// файл читается порциями и целиком в памяти не хранится
+vector<unsigned char> runPipelineForward(const Pipeline& pipeline, istream& input) {
+    if (pipeline.steps.empty() || !isStreamingStage(pipeline.steps.front().stage)) {
+        vector<unsigned char> content((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+        return runPipelineForward(pipeline, move(content));
+    }
+
+    vector<unsigned char> staged;
+    streamStageForward(pipeline.steps.front().stage, input, staged);
+    return runPipelineForward(pipeline, move(staged), 1);
+}
+
+// Обратный проход с записью в файл. Первая стадия, если она потоковая,
+// пишет результат в файл по кадрам, не собирая его целиком
+void runPipelineInverse(const Pipeline& pipeline, vector<unsigned char> input, ostream& output) {
+    if (pipeline.steps.empty() || !isStreamingStage(pipeline.steps.front().stage)) {
+        vector<unsigned char> result = runPipelineInverse(pipeline, move(input));
+        output.write(reinterpret_cast<const char*>(result.data()), result.size());
+        return;
+    }
+
+    vector<unsigned char> next;
+    for (size_t i = pipeline.steps.size() - 1; i > 0; --i) {
+        next.clear();
+        pipeline.steps[i].inverse(input, next);
+        swap(input, next);
+    }
+    streamStageInverse(pipeline.steps.front().stage, input, output);
+}
+
+// Потоковые функции у стадии необязательны
+bool isStreamingStage(const StageModule* stage) {
+    return stage && stage->chunkSize && stage->forwardChunkFunction && stage->inverseFrameFunction;
+}
+
+// Потоковый прямой проход стадии: порции по chunkSize байт читаются и сразу сжимаются в кадры
+void streamStageForward(const StageModule* stage, istream& input, vector<unsigned char>& output) {
+    vector<unsigned char> chunk(stage->chunkSize);
+    while (true) {
+        input.read(reinterpret_cast<char*>(chunk.data()), chunk.size());
+        size_t length = static_cast<size_t>(input.gcount());
+        if (length) stage->forwardChunkFunction(chunk.data(), length, output);
+        if (length < chunk.size()) break;
+    }
+    if (input.bad()) throw runtime_error(stage->name + ". Ошибка чтения входных данных");
+    stage->forwardChunkFunction(chunk.data(), 0, output); // Конец потока
+}
+
+// Потоковый обратный проход стадии: кадры разбираются по одному и сразу пишутся
+void streamStageInverse(const StageModule* stage, const vector<unsigned char>& input, ostream& output) {
+    vector<unsigned char> decoded;
+    size_t offset = 0;
+    bool finished = false;
+
+    while (!finished) {
+        decoded.clear();
+        size_t consumed = stage->inverseFrameFunction(input.data() + offset, input.size() - offset, decoded, finished);
+        if (!consumed) throw runtime_error(stage->name + ". Поток оборвался до конца данных");
+        offset += consumed;
+        output.write(reinterpret_cast<const char*>(decoded.data()), decoded.size());
+    }
+    // Как и при обработке буфера целиком, данные после конца потока - ошибка
+    if (offset != input.size()) throw runtime_error(stage->name + ". Лишние байты после конца потока");
+    if (!output) throw runtime_error(stage->name + ". Ошибка записи выходных данных");
+}
@@ -0,0 +1,39 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "cipher/interface.h"
+#include "stage/interface.h"
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <iostream>
+
+// Функция шага конвейера: читает входной буфер, пишет в выходной
+typedef std::function<void(const std::vector<unsigned char>&, std::vector<unsigned char>&)> StepFunc;
+
+// Шаг конвейера (стадия или шифр)
+struct PipelineStep {
+    std::string name;
+    StepFunc forward;
+    StepFunc inverse;
+    const StageModule* stage = nullptr; // Для шифров nullptr
+};
+
+// Конвейер: шаги выполняются по порядку, обратный проход - в обратном порядке
+struct Pipeline {
+    std::vector<PipelineStep> steps;
+};
+
+void addStage(Pipeline& pipeline, const StageModule* stage);
+void addCipher(Pipeline& pipeline, const CipherModule* cipher, const std::vector<unsigned char>& key, const std::vector<unsigned char>* pNonce);
+std::string describePipeline(const Pipeline& pipeline);
+std::vector<unsigned char> runPipelineForward(const Pipeline& pipeline, std::vector<unsigned char> input, size_t firstStep = 0);
+std::vector<unsigned char> runPipelineForward(const Pipeline& pipeline, std::istream& input);
+std::vector<unsigned char> runPipelineInverse(const Pipeline& pipeline, std::vector<unsigned char> input);
+void runPipelineInverse(const Pipeline& pipeline, std::vector<unsigned char> input, std::ostream& output);
+bool isStreamingStage(const StageModule* stage);
+void streamStageForward(const StageModule* stage, std::istream& input, std::vector<unsigned char>& output);
+void streamStageInverse(const StageModule* stage, const std::vector<unsigned char>& input, std::ostream& output);
+
+#endif
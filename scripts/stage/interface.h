@@ -0,0 +1,50 @@
+#ifndef STAGE_INTERFACE_H
+#define STAGE_INTERFACE_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Объявляем тип функции стадии конвейера
+// Стадия пишет результат в выходной буфер, переданный конвейером
+typedef void (*StageFunc)(
+    const std::vector<unsigned char>& input,
+    std::vector<unsigned char>& output
+);
+
+// Потоковое прямое преобразование одной порции (не больше chunkSize байт).
+// Результат дописывается в конец output. Пустая порция означает конец потока
+typedef void (*StageChunkFunc)(
+    const unsigned char* data,
+    size_t length,
+    std::vector<unsigned char>& output
+);
+
+// Потоковое обратное преобразование. Разбирает один кадр из начала data,
+// дописывает результат в output и возвращает число прочитанных байт.
+// 0 - кадр пришел не целиком, finished - найден конец потока
+typedef size_t (*StageFrameFunc)(
+    const unsigned char* data,
+    size_t length,
+    std::vector<unsigned char>& output,
+    bool& finished
+);
+
+// Структура с описанием стадии (сжатие и т.п.)
+// Обязательны только forwardFunction и inverseFunction. Потоковые поля можно
+// оставить нулевыми, тогда приложение обрабатывает данные стадии целиком.
+// Номера версии у структуры нет: .so стадий собираются с тем же interface.h,
+// что и приложение, и при изменении структуры их нужно пересобрать
+struct StageModule {
+    std::string name;
+    StageFunc forwardFunction; // Прямое преобразование (перед шифрованием)
+    StageFunc inverseFunction; // Обратное преобразование (после дешифрования)
+    size_t chunkSize = 0; // Размер порции для потоковой обработки
+    StageChunkFunc forwardChunkFunction = nullptr; // Потоковое прямое преобразование
+    StageFrameFunc inverseFrameFunction = nullptr; // Потоковое обратное преобразование
+};
+
+// Функция, которую каждая .so стадии будет экспортировать
+extern "C" StageModule* createStageModule();
+
+#endif
@@ -0,0 +1,320 @@
+#include "interface.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <exception>
+
+using namespace std;
+
+// Формат потока - последовательность самостоятельных кадров:
+//   исходный размер чанка (4 байта) | размер данных (4 байта) | данные
+// Старший бит размера данных означает, что чанк сохранен без сжатия.
+// Поток завершается кадром с нулевым исходным размером.
+// Заранее общий размер не нужен, поэтому кадры можно писать и читать по одному,
+// а при обработке буфера целиком - сжимать и распаковывать параллельно.
+
+const size_t CHUNK_SIZE = 64 * 1024; // Смещение совпадения всегда помещается в 2 байта
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+const int HASH_BITS = 12;
+const size_t FRAME_HEADER_SIZE = 8;
+const uint32_t STORED_FLAG = 0x80000000u;
+
+// Чтение 32-битного слова без требований к выравниванию
+uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Хэш четырех байт для поиска совпадений
+uint32_t hash32(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void putLE(vector<unsigned char>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+uint64_t getLE(const unsigned char* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return value;
+}
+
+// Продолжение длины байтами 255, как в LZ4
+void putLength(vector<unsigned char>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+// Последовательность: токен, литералы, смещение (если есть совпадение)
+void emitSequence(
+    vector<unsigned char>& out,
+    const unsigned char* literals, size_t literalLength,
+    size_t offset, size_t matchLength)
+{
+    size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+    unsigned char token = static_cast<unsigned char>((min<size_t>(literalLength, 15) << 4) | min<size_t>(matchCode, 15));
+    out.push_back(token);
+    if (literalLength >= 15) putLength(out, literalLength - 15);
+    out.insert(out.end(), literals, literals + literalLength);
+
+    if (!matchLength) return;
+    putLE(out, offset, 2);
+    if (matchCode >= 15) putLength(out, matchCode - 15);
+}
+
+// Сжатие одного чанка. Последняя последовательность содержит только литералы
+vector<unsigned char> compressBlock(const unsigned char* src, size_t length) {
+    vector<unsigned char> out;
+    out.reserve(length + length / 255 + 16);
+
+    vector<uint16_t> table(size_t(1) << HASH_BITS, 0);
+    size_t anchor = 0;
+    size_t pos = 0;
+    size_t misses = 0;
+
+    while (pos + MIN_MATCH <= length) {
+        uint32_t sequence = read32(src + pos);
+        uint32_t h = hash32(sequence);
+        size_t candidate = table[h];
+        table[h] = static_cast<uint16_t>(pos);
+
+        if (candidate < pos && pos - candidate <= MAX_OFFSET && read32(src + candidate) == sequence) {
+            size_t matchLength = MIN_MATCH;
+            while (pos + matchLength < length && src[candidate + matchLength] == src[pos + matchLength]) ++matchLength;
+
+            emitSequence(out, src + anchor, pos - anchor, pos - candidate, matchLength);
+            pos += matchLength;
+            anchor = pos;
+            misses = 0;
+        }
+        else {
+            // На несжимаемых данных шаг постепенно растет
+            pos += 1 + (misses++ >> 6);
+        }
+    }
+
+    emitSequence(out, src + anchor, length - anchor, 0, 0);
+    return out;
+}
+
+// Чтение продолжения длины с проверкой границ
+size_t getLength(const unsigned char* src, size_t srcLength, size_t& ip) {
+    size_t length = 0;
+    unsigned char byte;
+    do {
+        if (ip >= srcLength) throw runtime_error("LZFAST. Поврежденные данные: обрыв длины");
+        byte = src[ip++];
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+// Распаковка одного чанка прямо в выходной буфер
+void decompressBlock(const unsigned char* src, size_t srcLength, unsigned char* dst, size_t dstLength) {
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (true) {
+        if (ip >= srcLength) throw runtime_error("LZFAST. Поврежденные данные: нет токена");
+        unsigned char token = src[ip++];
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15) literalLength += getLength(src, srcLength, ip);
+        if (literalLength > srcLength - ip || literalLength > dstLength - op)
+            throw runtime_error("LZFAST. Поврежденные данные: литералы за границей");
+        memcpy(dst + op, src + ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip == srcLength) break; // Последняя последовательность
+
+        if (srcLength - ip < 2) throw runtime_error("LZFAST. Поврежденные данные: обрыв смещения");
+        size_t offset = getLE(src + ip, 2);
+        ip += 2;
+        size_t matchLength = (token & 0x0F);
+        if (matchLength == 15) matchLength += getLength(src, srcLength, ip);
+        matchLength += MIN_MATCH;
+
+        if (offset == 0 || offset > op || matchLength > dstLength - op)
+            throw runtime_error("LZFAST. Поврежденные данные: неверное совпадение");
+        const unsigned char* match = dst + op - offset;
+        if (offset >= matchLength)
+            memcpy(dst + op, match, matchLength);
+        else // Совпадение перекрывается с копируемой областью, копируем побайтно
+            for (size_t i = 0; i < matchLength; ++i) dst[op + i] = match[i];
+        op += matchLength;
+    }
+
+    if (op != dstLength) throw runtime_error("LZFAST. Поврежденные данные: неверный размер чанка");
+}
+
+// Выполнение задачи для каждого чанка на нескольких потоках
+template <typename Task>
+void forEachChunk(size_t chunkCount, Task task) {
+    size_t threadCount = min<size_t>(max(1u, thread::hardware_concurrency()), chunkCount);
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < chunkCount; ++i) task(i);
+        return;
+    }
+
+    atomic<size_t> nextChunk(0);
+    exception_ptr error;
+    atomic<bool> failed(false);
+    vector<thread> workers;
+    workers.reserve(threadCount);
+
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&]() {
+            size_t i;
+            while (!failed && (i = nextChunk++) < chunkCount) {
+                try {
+                    task(i);
+                }
+                catch (...) {
+                    if (!failed.exchange(true)) error = current_exception();
+                }
+            }
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    if (error) rethrow_exception(error);
+}
+
+// Потоковое сжатие одной порции в кадр. Пустая порция - кадр конца потока
+void lzfastCompressChunk(const unsigned char* data, size_t length, vector<unsigned char>& output) {
+    if (length > CHUNK_SIZE) throw invalid_argument("LZFAST. Порция больше размера чанка");
+    if (length == 0) {
+        putLE(output, 0, 4);
+        putLE(output, 0, 4);
+        return;
+    }
+
+    vector<unsigned char> block = compressBlock(data, length);
+    putLE(output, length, 4);
+    if (block.size() < length) {
+        putLE(output, block.size(), 4);
+        output.insert(output.end(), block.begin(), block.end());
+    }
+    else { // Сжатие не помогло, сохраняем как есть
+        putLE(output, length | STORED_FLAG, 4);
+        output.insert(output.end(), data, data + length);
+    }
+}
+
+// Описание кадра в сжатом потоке
+struct ChunkInfo {
+    size_t srcOffset;
+    size_t srcLength;
+    size_t dstOffset;
+    size_t dstLength;
+    bool stored;
+};
+
+// Разбор заголовка кадра. false - кадр пришел не целиком
+bool parseFrame(const unsigned char* data, size_t length, ChunkInfo& chunk) {
+    if (length < FRAME_HEADER_SIZE) return false;
+    uint32_t storedField = static_cast<uint32_t>(getLE(data + 4, 4));
+    chunk.stored = (storedField & STORED_FLAG) != 0;
+    chunk.srcOffset = FRAME_HEADER_SIZE;
+    chunk.srcLength = storedField & ~STORED_FLAG;
+    chunk.dstLength = getLE(data, 4);
+
+    if (chunk.dstLength > CHUNK_SIZE || (chunk.dstLength == 0 && storedField != 0) ||
+        (chunk.stored && chunk.srcLength != chunk.dstLength))
+        throw runtime_error("LZFAST. Поврежденные данные: неверный заголовок кадра");
+    return chunk.srcLength <= length - FRAME_HEADER_SIZE;
+}
+
+// Распаковка одного кадра из буфера в выходной буфер
+void decompressChunk(const unsigned char* src, const ChunkInfo& chunk, unsigned char* dst) {
+    if (chunk.stored)
+        memcpy(dst, src + chunk.srcOffset, chunk.dstLength);
+    else
+        decompressBlock(src + chunk.srcOffset, chunk.srcLength, dst, chunk.dstLength);
+}
+
+// Потоковая распаковка одного кадра из начала data
+size_t lzfastDecompressFrame(const unsigned char* data, size_t length, vector<unsigned char>& output, bool& finished) {
+    ChunkInfo chunk;
+    if (!parseFrame(data, length, chunk)) return 0;
+
+    finished = chunk.dstLength == 0;
+    if (finished) return FRAME_HEADER_SIZE;
+
+    size_t start = output.size();
+    output.resize(start + chunk.dstLength);
+    decompressChunk(data, chunk, output.data() + start);
+    return FRAME_HEADER_SIZE + chunk.srcLength;
+}
+
+// Сжатие буфера целиком: чанки сжимаются параллельно, кадры склеиваются по порядку
+void lzfastCompress(const vector<unsigned char>& input, vector<unsigned char>& output) {
+    size_t chunkCount = (input.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    vector<vector<unsigned char>> frames(chunkCount);
+
+    forEachChunk(chunkCount, [&](size_t i) {
+        size_t start = i * CHUNK_SIZE;
+        lzfastCompressChunk(input.data() + start, min(CHUNK_SIZE, input.size() - start), frames[i]);
+    });
+
+    size_t totalSize = FRAME_HEADER_SIZE;
+    for (const vector<unsigned char>& frame : frames) totalSize += frame.size();
+
+    output.clear();
+    output.reserve(totalSize);
+    for (const vector<unsigned char>& frame : frames) output.insert(output.end(), frame.begin(), frame.end());
+    lzfastCompressChunk(nullptr, 0, output);
+}
+
+// Распаковка буфера целиком: сначала разбираются заголовки кадров,
+// затем чанки распаковываются параллельно в общий буфер
+void lzfastDecompress(const vector<unsigned char>& input, vector<unsigned char>& output) {
+    vector<ChunkInfo> chunks;
+    size_t ip = 0;
+    size_t op = 0;
+    while (true) {
+        ChunkInfo chunk;
+        if (!parseFrame(input.data() + ip, input.size() - ip, chunk))
+            throw runtime_error("LZFAST. Поврежденные данные: обрыв кадра");
+        if (chunk.dstLength == 0) {
+            ip += FRAME_HEADER_SIZE;
+            break;
+        }
+        chunk.srcOffset += ip;
+        chunk.dstOffset = op;
+        chunks.push_back(chunk);
+        ip += FRAME_HEADER_SIZE + chunk.srcLength;
+        op += chunk.dstLength;
+    }
+    if (ip != input.size())
+        throw runtime_error("LZFAST. Поврежденные данные: лишние байты после конца потока");
+
+    output.resize(op);
+    forEachChunk(chunks.size(), [&](size_t i) {
+        decompressChunk(input.data(), chunks[i], output.data() + chunks[i].dstOffset);
+    });
+}
+
+// Экспортируемая функция для создания модуля
+extern "C" StageModule* createStageModule() {
+    static StageModule lzfastModule = {
+        "LZFAST", // Название
+        lzfastCompress, // Сжатие
+        lzfastDecompress, // Распаковка
+        CHUNK_SIZE, // Размер порции
+        lzfastCompressChunk, // Потоковое сжатие
+        lzfastDecompressFrame // Потоковая распаковка
+    };
+    return &lzfastModule;
+}